@@ -0,0 +1,20 @@
+#! /bin/bash
+
+# Usage:
+#   ./aqc-batch.sh "RUNS_CONFIGS" plots.json [N_WORKERS]
+# where RUNS_CONFIGS is a list of runs configurations separated by commas or spaces, or a quoted glob pattern, e.g.
+#   ./aqc-batch.sh "runs-LHC23zz*-apass5.json" plots-MCH.json 8
+
+export INFOLOGGER_MODE=stdout
+export SCRIPTDIR=$(readlink -f $(dirname $0))
+
+RUNS_CONFIGS="$1"
+PLOTS_CONFIG="$2"
+N_WORKERS="${3:-0}"
+
+ID=$(jq ".id" "${PLOTS_CONFIG}" | tr -d "\"")
+
+mkdir -p "outputs/${ID}"
+
+echo "root -b -q \"aqc_batch.C(\\\"${RUNS_CONFIGS}\\\", \\\"${PLOTS_CONFIG}\\\", ${N_WORKERS})\""
+root -b -q "aqc_batch.C(\"${RUNS_CONFIGS}\", \"${PLOTS_CONFIG}\", ${N_WORKERS})"
@@ -0,0 +1,25 @@
+#! /bin/bash
+
+# Usage:
+#   ./aqc-compare-passes.sh runs-A.json runs-B.json plots.json
+# for example:
+#   ./aqc-compare-passes.sh runs-LHC23zzf-cpass0.json runs-LHC23zzf-apass5.json plots-MCH.json
+
+export INFOLOGGER_MODE=stdout
+export SCRIPTDIR=$(readlink -f $(dirname $0))
+
+RUNS_CONFIG_A="$1"
+RUNS_CONFIG_B="$2"
+PLOTS_CONFIG="$3"
+
+YEAR=$(jq ".year" "${RUNS_CONFIG_A}" | tr -d "\"")
+PERIOD=$(jq ".period" "${RUNS_CONFIG_A}" | tr -d "\"")
+PASS_A=$(jq ".pass" "${RUNS_CONFIG_A}" | tr -d "\"")
+PASS_B=$(jq ".pass" "${RUNS_CONFIG_B}" | tr -d "\"")
+
+ID=$(jq ".id" "${PLOTS_CONFIG}" | tr -d "\"")
+
+mkdir -p "outputs/${ID}/${YEAR}/${PERIOD}/${PASS_B}-vs-${PASS_A}"
+
+echo "root -b -q \"aqc_compare_passes.C(\\\"${RUNS_CONFIG_A}\\\", \\\"${RUNS_CONFIG_B}\\\", \\\"${PLOTS_CONFIG}\\\")\""
+root -b -q "aqc_compare_passes.C(\"${RUNS_CONFIG_A}\", \"${RUNS_CONFIG_B}\", \"${PLOTS_CONFIG}\")"
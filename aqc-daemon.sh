@@ -0,0 +1,51 @@
+#! /bin/bash
+
+# Usage:
+#   ./aqc-daemon.sh start runs.json plots.json [POLL_INTERVAL]
+#   ./aqc-daemon.sh refresh|status|stop runs.json plots.json
+#   ./aqc-daemon.sh render runs.json plots.json [PLOT|all] [INTERVAL]
+
+export INFOLOGGER_MODE=stdout
+export SCRIPTDIR=$(readlink -f $(dirname $0))
+
+COMMAND="$1"
+RUNS_CONFIG="$2"
+PLOTS_CONFIG="$3"
+POLL_INTERVAL="${4:-60}"
+
+YEAR=$(jq ".year" "${RUNS_CONFIG}" | tr -d "\"")
+PERIOD=$(jq ".period" "${RUNS_CONFIG}" | tr -d "\"")
+PASS=$(jq ".pass" "${RUNS_CONFIG}" | tr -d "\"")
+
+ID=$(jq ".id" "${PLOTS_CONFIG}" | tr -d "\"")
+
+DAEMON_DIR="outputs/${ID}/${YEAR}/${PERIOD}/${PASS}/daemon"
+mkdir -p "${DAEMON_DIR}"
+
+case "${COMMAND}" in
+    start)
+        echo "Starting daemon, log file: ${DAEMON_DIR}/log.txt"
+        nohup root -b -q "aqc_daemon.C(\"${RUNS_CONFIG}\", \"${PLOTS_CONFIG}\", ${POLL_INTERVAL})" >& "${DAEMON_DIR}/log.txt" &
+        ;;
+    refresh|stop)
+        echo "${COMMAND}" > "${DAEMON_DIR}/command"
+        ;;
+    render)
+        echo "render ${4:-all} ${5:--1}" > "${DAEMON_DIR}/command"
+        ;;
+    status)
+        echo "status" > "${DAEMON_DIR}/command"
+        # wait for the daemon to pick up the command
+        for i in $(seq 1 10); do
+            if [ ! -e "${DAEMON_DIR}/command" ]; then
+                break
+            fi
+            sleep 1
+        done
+        cat "${DAEMON_DIR}/status.json"
+        ;;
+    *)
+        echo "Unknown command \"${COMMAND}\", should be one of start, refresh, status, render, stop"
+        exit 1
+        ;;
+esac
@@ -1,5 +1,8 @@
 #! /bin/bash
 
+# the exit status of the processing is not hidden by the tee of the log
+set -o pipefail
+
 export INFOLOGGER_MODE=stdout
 export SCRIPTDIR=$(readlink -f $(dirname $0))
 #echo "SCRIPTDIR: ${SCRIPTDIR}"
@@ -13,9 +16,16 @@ PASS=$(jq ".pass" "${RUNS_CONFIG}" | tr -d "\"")
 
 ID=$(jq ".id" "${PLOTS_CONFIG}" | tr -d "\"")
 
-mkdir -p "outputs/${ID}/${YEAR}/${PERIOD}/${PASS}"
+OUTPUT_DIR="outputs/${ID}/${YEAR}/${PERIOD}/${PASS}"
+mkdir -p "${OUTPUT_DIR}"
 
+# the output of the processing is shown and saved at the same time in the log file of the period
 echo "root -b -q \"aqc_process.C(\\\"${RUNS_CONFIG}\\\", \\\"${PLOTS_CONFIG}\\\")\""
-root -b -q "aqc_process.C(\"${RUNS_CONFIG}\", \"${PLOTS_CONFIG}\")" #>& "outputs/${ID}/log.txt"
+root -b -q "aqc_process.C(\"${RUNS_CONFIG}\", \"${PLOTS_CONFIG}\")" 2>&1 | tee "${OUTPUT_DIR}/log.txt"
+STATUS=$?
 
-cat "outputs/${ID}/log.txt" | grep "Bad time interval"
+echo ""
+grep "Bad time interval" "${OUTPUT_DIR}/log.txt"
+echo ""
+echo "Log saved in \"${OUTPUT_DIR}/log.txt\", reports in \"${OUTPUT_DIR}/report.json\" and \"${OUTPUT_DIR}/report.jsonl\""
+exit ${STATUS}
@@ -7,5 +7,7 @@ export SCRIPTDIR=$(readlink -f $(dirname $0))
 RUNS_CONFIG="$1"
 PLOTS_CONFIG="$2"
 
-echo "root -l -b -q \"aqc_qcdb_lookup.C(\\\"${RUNS_CONFIG}\\\")\""
-root -l -b -q "aqc_qcdb_lookup.C(\"${RUNS_CONFIG}\")" #>& "outputs/${ID}/log.txt"
+NTHREADS="${3:-8}"
+
+echo "root -l -b -q \"aqc_qcdb_lookup.C(\\\"${RUNS_CONFIG}\\\", \\\"${PLOTS_CONFIG}\\\", ${NTHREADS})\""
+root -l -b -q "aqc_qcdb_lookup.C(\"${RUNS_CONFIG}\", \"${PLOTS_CONFIG}\", ${NTHREADS})" #>& "outputs/${ID}/log.txt"
@@ -0,0 +1,119 @@
+#! /usr/bin/env python3
+
+# Minimal stand-in for the QC repository, implementing the subset of the CCDB REST API
+# that is used by aqc_qcdb_lookup.C and by the "qcdb" input mode of aqc_process.C:
+#
+#   GET /browse/PATH[/KEY=VALUE...]         listing of all the object versions
+#   GET /latest/PATH[/KEY=VALUE...]         listing of the most recent object version
+#   GET /PATH/TIMESTAMP[/KEY=VALUE...]      retrieval of the object valid at TIMESTAMP
+#
+# The objects are served from a local directory, filled with aqc_qcdb_export.C.
+#
+# Usage: ./aqc-qcdb-standin.py STORAGEDIR [PORT]
+# and set "qcdbUrl": "http://localhost:PORT" in the runs configuration.
+
+import http.server
+import json
+import os
+import sys
+import urllib.parse
+
+STORAGE = os.path.abspath(sys.argv[1] if len(sys.argv) > 1 else "qcdb-standin")
+PORT = int(sys.argv[2]) if len(sys.argv) > 2 else 8084
+
+
+def split_request(path):
+    # split the request path into object path, optional timestamp and metadata filters
+    segments = [s for s in urllib.parse.unquote(path.split("?")[0]).split("/") if s]
+    metadata = dict(s.split("=", 1) for s in segments if "=" in s)
+    segments = [s for s in segments if "=" not in s]
+    timestamp = None
+    if segments and segments[-1].isdigit():
+        timestamp = int(segments.pop())
+    return "/".join(segments), timestamp, metadata
+
+
+def find_objects(path, metadata):
+    # all the object versions stored under PATH that match the metadata filters, most recent first
+    directory = os.path.join(STORAGE, path)
+    objects = []
+    if not os.path.isdir(directory):
+        return objects
+    for name in os.listdir(directory):
+        if not name.endswith(".json"):
+            continue
+        with open(os.path.join(directory, name)) as f:
+            entry = json.load(f)
+        if any(str(entry.get(k)) != v for k, v in metadata.items()):
+            continue
+        entry["path"] = path
+        entry["id"] = name[:-len(".json")]
+        entry["fileName"] = os.path.join(directory, entry["id"] + ".root")
+        objects.append(entry)
+    objects.sort(key=lambda o: o["createTime"], reverse=True)
+    return objects
+
+
+def find_latest_objects(prefix, metadata):
+    # most recent version of each object stored below PREFIX, for the listings of a whole folder ("PREFIX/*")
+    objects = []
+    for directory, _, names in os.walk(os.path.join(STORAGE, prefix)):
+        if any(name.endswith(".json") for name in names):
+            objects += find_objects(os.path.relpath(directory, STORAGE), metadata)[:1]
+    return objects
+
+
+class Handler(http.server.BaseHTTPRequestHandler):
+
+    def send_json(self, content):
+        body = json.dumps(content).encode()
+        self.send_response(200)
+        self.send_header("Content-Type", "application/json")
+        self.send_header("Content-Length", str(len(body)))
+        self.end_headers()
+        self.wfile.write(body)
+
+    def do_HEAD(self):
+        self.send_response(200)
+        self.end_headers()
+
+    def do_GET(self):
+        if self.path.startswith("/browse/") or self.path.startswith("/latest/"):
+            path, _, metadata = split_request(self.path[len("/browse/"):])
+            if path.endswith("/*"):
+                objects = find_latest_objects(path[:-2], metadata)
+            else:
+                objects = find_objects(path, metadata)
+                if self.path.startswith("/latest/"):
+                    objects = objects[:1]
+            self.send_json({"objects": [{k: v for k, v in o.items() if k != "fileName"} for o in objects], "subfolders": []})
+            return
+
+        path, timestamp, metadata = split_request(self.path)
+        objects = [o for o in find_objects(path, metadata)
+                   if timestamp is None or o["validFrom"] <= timestamp < o["validUntil"]]
+        if not objects:
+            self.send_error(404)
+            return
+
+        entry = objects[0]
+        with open(entry["fileName"], "rb") as f:
+            body = f.read()
+        self.send_response(200)
+        self.send_header("Content-Type", "application/octet-stream")
+        self.send_header("Content-Length", str(len(body)))
+        self.send_header("Content-Location", self.path)
+        self.send_header("ETag", '"' + entry["id"] + '"')
+        self.send_header("Valid-From", str(entry["validFrom"]))
+        self.send_header("Valid-Until", str(entry["validUntil"]))
+        self.send_header("Created", str(entry["createTime"]))
+        for k, v in entry.items():
+            if k not in ("path", "id", "fileName", "validFrom", "validUntil", "createTime"):
+                self.send_header(k, str(v))
+        self.end_headers()
+        self.wfile.write(body)
+
+
+if __name__ == "__main__":
+    print(f"Serving QCDB stand-in from {STORAGE} on port {PORT}")
+    http.server.ThreadingHTTPServer(("", PORT), Handler).serve_forever()
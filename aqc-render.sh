@@ -0,0 +1,21 @@
+#! /bin/bash
+
+# Usage:
+#   ./aqc-render.sh runs.json plots.json [PLOT|all] [INTERVAL]
+# renders the images of the HTML report that were not rendered during the processing, for example
+#   ./aqc-render.sh runs.json plots.json MCH-Tracks-TrackEta 12
+
+export INFOLOGGER_MODE=stdout
+export SCRIPTDIR=$(readlink -f $(dirname $0))
+
+RUNS_CONFIG="$1"
+PLOTS_CONFIG="$2"
+PLOT="${3:-all}"
+INTERVAL="${4:--1}"
+
+if [ "${PLOT}" = "all" ]; then
+    PLOT=""
+fi
+
+echo "root -b -q \"aqc_render.C(\\\"${RUNS_CONFIG}\\\", \\\"${PLOTS_CONFIG}\\\", \\\"${PLOT}\\\", ${INTERVAL})\""
+root -b -q "aqc_render.C(\"${RUNS_CONFIG}\", \"${PLOTS_CONFIG}\", \"${PLOT}\", ${INTERVAL})"
@@ -0,0 +1,190 @@
+#ifndef AQC_CACHE_H_
+#define AQC_CACHE_H_
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Compact binary cache of the time slices of one plot, that can be memory-mapped and used without any deserialization.
+// The file contains, in this order and in native byte order:
+// - the header
+// - the nBins + 1 low edges of the x axis, and the nBinsY + 1 low edges of the y axis (none for 1-D histograms)
+// - one fixed-size record for each time slice
+// - the packed bin contents and errors of all the slices (nValues doubles each)
+// - for profiles, the number of entries of each packed bin (nValues doubles)
+// - for sparse 2-D histograms, the global cell indexes of the packed values (nValues 32-bit integers)
+// All the sections start at offsets that are multiple of 8 bytes.
+// The sizes and counts of the header, and the ranges of the records, are checked against the size of the file before
+// the file is used, such that a truncated or corrupted file is simply ignored.
+
+constexpr char kBinaryCacheMagic[8] = { 'A', 'Q', 'C', 'B', 'I', 'N', '0', '2' };
+
+struct BinaryCacheHeader
+{
+  char magic[8];
+  // hash of the signature of the inputs, the file is only valid if it matches the current one
+  uint64_t signature;
+  int32_t nBins;
+  int32_t nBinsY;
+  int32_t sparse;
+  int32_t profile;
+  uint64_t nSlices;
+  uint64_t nValues;
+  // titles of the histograms and of their axes, used for the drawing
+  char title[256];
+  char xTitle[128];
+  char yTitle[128];
+};
+
+struct BinaryCacheRecord
+{
+  int32_t runNumber;
+  int32_t reserved;
+  uint64_t validityMin;
+  uint64_t validityMax;
+  double rate;
+  double entries;
+  double mean;
+  // offset and number of the packed values of the slice
+  uint64_t offset;
+  uint64_t size;
+};
+
+// read-only memory mapping of a cache file
+class BinaryCacheFile
+{
+ public:
+  BinaryCacheFile(const std::string& fileName)
+  {
+    int fd = ::open(fileName.c_str(), O_RDONLY);
+    if (fd < 0) {
+      return;
+    }
+    struct stat st;
+    if (::fstat(fd, &st) == 0 && st.st_size >= (off_t)sizeof(BinaryCacheHeader)) {
+      void* data = ::mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+      if (data != MAP_FAILED) {
+        mData = (const char*)data;
+        mSize = st.st_size;
+      }
+    }
+    ::close(fd);
+
+    if (mData && !isConsistent()) {
+      ::munmap((void*)mData, mSize);
+      mData = nullptr;
+    }
+  }
+
+  ~BinaryCacheFile()
+  {
+    if (mData) {
+      ::munmap((void*)mData, mSize);
+    }
+  }
+
+  BinaryCacheFile(const BinaryCacheFile&) = delete;
+  BinaryCacheFile& operator=(const BinaryCacheFile&) = delete;
+
+  bool isValid() const { return mData != nullptr; }
+
+  const BinaryCacheHeader& header() const { return *(const BinaryCacheHeader*)mData; }
+  const double* xEdges() const { return (const double*)(mData + sizeof(BinaryCacheHeader)); }
+  const double* yEdges() const { return xEdges() + header().nBins + 1; }
+  const BinaryCacheRecord* records() const { return (const BinaryCacheRecord*)(yEdges() + getNYEdges()); }
+  const double* contents() const { return (const double*)(records() + header().nSlices); }
+  const double* errors() const { return contents() + header().nValues; }
+  const double* binEntries() const { return errors() + header().nValues; }
+  const uint32_t* indexes() const { return (const uint32_t*)(binEntries() + (header().profile ? header().nValues : 0)); }
+
+ private:
+  size_t getNYEdges() const { return (header().nBinsY > 0) ? header().nBinsY + 1 : 0; }
+
+  // the counts are bounded by the file size before any size is computed from them, such that the computations
+  // cannot overflow
+  bool isConsistent() const
+  {
+    const auto& h = header();
+    if (std::memcmp(h.magic, kBinaryCacheMagic, sizeof(kBinaryCacheMagic)) != 0) {
+      return false;
+    }
+    if (h.nBins < 1 || h.nBinsY < 0 || (h.sparse != 0 && h.nBinsY == 0) || (h.profile != 0 && h.nBinsY != 0) ||
+        (uint64_t)h.nBins > mSize || (uint64_t)h.nBinsY > mSize || h.nSlices > mSize || h.nValues > mSize) {
+      return false;
+    }
+    uint64_t nCells = (uint64_t)(h.nBins + 2) * (h.nBinsY > 0 ? h.nBinsY + 2 : 1);
+    uint64_t expectedSize = sizeof(BinaryCacheHeader) + (h.nBins + 1 + getNYEdges()) * sizeof(double) +
+                            h.nSlices * sizeof(BinaryCacheRecord) + (h.profile ? 3 : 2) * h.nValues * sizeof(double) +
+                            (h.sparse ? h.nValues * sizeof(uint32_t) : 0);
+    if (expectedSize != mSize || nCells > UINT32_MAX) {
+      return false;
+    }
+
+    // each record must refer to its own range of packed values, with all the cells for the dense histograms and
+    // valid cell indexes for the sparse ones
+    const BinaryCacheRecord* r = records();
+    for (uint64_t i = 0; i < h.nSlices; i++) {
+      if (r[i].size > h.nValues || r[i].offset > h.nValues - r[i].size) {
+        return false;
+      }
+      if (h.sparse ? (r[i].size > nCells) : (r[i].size != nCells)) {
+        return false;
+      }
+    }
+    if (h.sparse) {
+      const uint32_t* cellIndexes = indexes();
+      for (uint64_t i = 0; i < h.nValues; i++) {
+        if (cellIndexes[i] >= nCells) return false;
+      }
+    }
+    return true;
+  }
+
+  const char* mData{ nullptr };
+  size_t mSize{ 0 };
+};
+
+// the file is written under a temporary name and then renamed, such that readers never see a partially written file
+inline bool writeBinaryCache(const std::string& fileName, const BinaryCacheHeader& header,
+                             const std::vector<double>& xEdges, const std::vector<double>& yEdges,
+                             const std::vector<BinaryCacheRecord>& records, const std::vector<double>& contents,
+                             const std::vector<double>& errors, const std::vector<double>& binEntries,
+                             const std::vector<uint32_t>& indexes)
+{
+  std::string tmpFileName = fileName + ".tmp";
+  FILE* f = std::fopen(tmpFileName.c_str(), "wb");
+  if (!f) {
+    return false;
+  }
+  bool ok = true;
+  auto write = [&](const void* data, size_t size) {
+    if (size > 0 && std::fwrite(data, 1, size, f) != size) ok = false;
+  };
+  write(&header, sizeof(header));
+  write(xEdges.data(), xEdges.size() * sizeof(double));
+  write(yEdges.data(), yEdges.size() * sizeof(double));
+  write(records.data(), records.size() * sizeof(BinaryCacheRecord));
+  write(contents.data(), contents.size() * sizeof(double));
+  write(errors.data(), errors.size() * sizeof(double));
+  if (header.profile) {
+    write(binEntries.data(), binEntries.size() * sizeof(double));
+  }
+  if (header.sparse) {
+    write(indexes.data(), indexes.size() * sizeof(uint32_t));
+  }
+  ok = (std::fclose(f) == 0) && ok;
+  if (!ok || std::rename(tmpFileName.c_str(), fileName.c_str()) != 0) {
+    std::remove(tmpFileName.c_str());
+    return false;
+  }
+  return true;
+}
+
+#endif // AQC_CACHE_H_
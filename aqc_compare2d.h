@@ -0,0 +1,343 @@
+#ifndef AQC_COMPARE2D_H_
+#define AQC_COMPARE2D_H_
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "./aqc_reference.h"
+
+// Cell-by-cell comparison of 2-D histograms with a reference, working directly on the bin arrays in the ROOT layout,
+// i.e. (nx + 2) x (ny + 2) cells including underflow and overflow, with the global bin index x + (nx + 2) * y.
+// The cells of the slices are read in the precision of the store (float or double), the sums are done in double
+// precision.
+
+// range of bins [xFirst, xLast] x [yFirst, yLast] considered in the comparison
+struct CellWindow
+{
+  int nx{ 0 };
+  int ny{ 0 };
+  int xFirst{ 1 };
+  int xLast{ 0 };
+  int yFirst{ 1 };
+  int yLast{ 0 };
+
+  size_t stride() const { return nx + 2; }
+  size_t nCells() const { return (size_t)(nx + 2) * (ny + 2); }
+};
+
+// connected group of bad cells, with its bounding box in bin indexes
+struct CellRegion
+{
+  size_t size{ 0 };
+  int xMin{ 0 };
+  int xMax{ 0 };
+  int yMin{ 0 };
+  int yMax{ 0 };
+};
+
+// the window is processed in tiles of kTileY rows x kTileX columns, such that the input and output cells of a tile
+// stay in cache, and the rows of each tile are traversed contiguously
+constexpr int kTileX = 128;
+constexpr int kTileY = 32;
+
+template <class F>
+inline void forEachTile(const CellWindow& window, F&& process)
+{
+  for (int yTile = window.yFirst; yTile <= window.yLast; yTile += kTileY) {
+    int yEnd = std::min(yTile + kTileY - 1, window.yLast);
+    for (int xTile = window.xFirst; xTile <= window.xLast; xTile += kTileX) {
+      int xEnd = std::min(xTile + kTileX - 1, window.xLast);
+      for (int y = yTile; y <= yEnd; y++) {
+        process(y, xTile, xEnd);
+      }
+    }
+  }
+}
+
+// sum of the cell contents inside the window
+template <class T>
+inline double getWindowIntegral(const CellWindow& window, const T* contents)
+{
+  double sum = 0;
+  forEachTile(window, [&](int y, int xBegin, int xEnd) {
+    const T* row = contents + y * window.stride();
+    for (int x = xBegin; x <= xEnd; x++) {
+      sum += row[x];
+    }
+  });
+  return sum;
+}
+
+// Compares the normalized contents of one slice with the normalized reference. For each cell in the window, the ratio
+// and its error are computed as in TH1::Divide(), and the cell is marked as bad in the mask if the deviation of the
+// ratio from unity exceeds threshold + nSigma * error. The significance (deviation / error) of each cell is stored if
+// requested. Returns the number of bad cells, the number of checked cells is the size of the window.
+// If the per-cell MADs of the rate interval are given, the cells are instead checked on their deviation in units of
+// MADs, see getMADDeviation(), which is also stored as significance.
+template <class T>
+inline size_t compareCells(const CellWindow& window, const T* contents, const T* errors, double norm,
+                           const double* referenceContents, const double* referenceErrors,
+                           double threshold, double nSigma, std::vector<uint8_t>& badMask,
+                           std::vector<float>* significances = nullptr,
+                           const double* referenceMADs = nullptr, double madThreshold = 0)
+{
+  badMask.assign(window.nCells(), 0);
+  if (significances) {
+    significances->assign(window.nCells(), 0);
+  }
+  size_t nBad = 0;
+  forEachTile(window, [&](int y, int xBegin, int xEnd) {
+    size_t offset = y * window.stride();
+    for (int x = xBegin; x <= xEnd; x++) {
+      size_t cell = offset + x;
+      double c1 = contents[cell] * norm;
+      double e1 = errors[cell] * norm;
+      double c2 = referenceContents[cell];
+      double e2 = referenceErrors[cell];
+      if (referenceMADs) {
+        double deviation = getMADDeviation(c1, e1, c2, e2, referenceMADs[cell]);
+        uint8_t bad = (deviation > madThreshold) ? 1 : 0;
+        badMask[cell] = bad;
+        nBad += bad;
+        if (significances) {
+          (*significances)[cell] = deviation;
+        }
+        continue;
+      }
+      double ratio = 0;
+      double error = 0;
+      if (c2 != 0) {
+        ratio = c1 / c2;
+        error = std::sqrt(e1 * e1 * c2 * c2 + e2 * e2 * c1 * c1) / (c2 * c2);
+      }
+      // the cells that are empty in both histograms carry no information
+      double deviation = (c1 == 0 && c2 == 0) ? 0 : std::fabs(ratio - 1.0);
+      uint8_t bad = (deviation > threshold + error * nSigma) ? 1 : 0;
+      badMask[cell] = bad;
+      nBad += bad;
+      if (significances) {
+        (*significances)[cell] = (error > 0) ? deviation / error : 0;
+      }
+    }
+  });
+  return nBad;
+}
+
+inline size_t getWindowSize(const CellWindow& window)
+{
+  if (window.xLast < window.xFirst || window.yLast < window.yFirst) {
+    return 0;
+  }
+  return (size_t)(window.xLast - window.xFirst + 1) * (window.yLast - window.yFirst + 1);
+}
+
+// Groups of at least minSize bad cells connected by their sides, found with a flood fill over the bad cells mask.
+inline std::vector<CellRegion> findConnectedRegions(const CellWindow& window, const std::vector<uint8_t>& badMask, size_t minSize)
+{
+  std::vector<CellRegion> regions;
+  std::vector<uint8_t> visited(badMask.size(), 0);
+  std::vector<size_t> stack;
+  size_t stride = window.stride();
+
+  forEachTile(window, [&](int y, int xBegin, int xEnd) {
+    for (int x = xBegin; x <= xEnd; x++) {
+      size_t seed = y * stride + x;
+      if (!badMask[seed] || visited[seed]) continue;
+
+      CellRegion region{ 0, x, x, y, y };
+      visited[seed] = 1;
+      stack.push_back(seed);
+      while (!stack.empty()) {
+        size_t cell = stack.back();
+        stack.pop_back();
+        int cx = cell % stride;
+        int cy = cell / stride;
+        region.size += 1;
+        region.xMin = std::min(region.xMin, cx);
+        region.xMax = std::max(region.xMax, cx);
+        region.yMin = std::min(region.yMin, cy);
+        region.yMax = std::max(region.yMax, cy);
+
+        const int dx[4] = { -1, 1, 0, 0 };
+        const int dy[4] = { 0, 0, -1, 1 };
+        for (int n = 0; n < 4; n++) {
+          int nx = cx + dx[n];
+          int ny = cy + dy[n];
+          if (nx < window.xFirst || nx > window.xLast || ny < window.yFirst || ny > window.yLast) continue;
+          size_t neighbour = ny * stride + nx;
+          if (!badMask[neighbour] || visited[neighbour]) continue;
+          visited[neighbour] = 1;
+          stack.push_back(neighbour);
+        }
+      }
+      if (region.size >= minSize) {
+        regions.push_back(region);
+      }
+    }
+  });
+  return regions;
+}
+
+// Sparse representation of mostly empty 2-D histograms: sorted global indexes of the non-empty cells, with their
+// contents and errors. All the operations below scale with the number of non-empty cells instead of the grid size.
+struct SparseCells
+{
+  std::vector<uint32_t> indexes;
+  std::vector<double> contents;
+  std::vector<double> errors;
+
+  size_t size() const { return indexes.size(); }
+};
+
+inline bool isInWindow(const CellWindow& window, size_t cell)
+{
+  int x = cell % window.stride();
+  int y = cell / window.stride();
+  return x >= window.xFirst && x <= window.xLast && y >= window.yFirst && y <= window.yLast;
+}
+
+template <class T>
+inline double getWindowIntegral(const CellWindow& window, const uint32_t* indexes, const T* contents, size_t n)
+{
+  double sum = 0;
+  for (size_t i = 0; i < n; i++) {
+    if (isInWindow(window, indexes[i])) sum += contents[i];
+  }
+  return sum;
+}
+
+// sum += scale * cells, with the errors added in quadrature, by merging the two sorted lists of indexes
+template <class T>
+inline void addSparseCells(SparseCells& sum, const uint32_t* indexes, const T* contents, const T* errors,
+                           size_t n, double scale)
+{
+  SparseCells result;
+  result.indexes.reserve(sum.size() + n);
+  result.contents.reserve(sum.size() + n);
+  result.errors.reserve(sum.size() + n);
+  size_t i = 0;
+  size_t j = 0;
+  while (i < sum.size() || j < n) {
+    if (j >= n || (i < sum.size() && sum.indexes[i] < indexes[j])) {
+      result.indexes.push_back(sum.indexes[i]);
+      result.contents.push_back(sum.contents[i]);
+      result.errors.push_back(sum.errors[i]);
+      i++;
+    } else if (i >= sum.size() || indexes[j] < sum.indexes[i]) {
+      result.indexes.push_back(indexes[j]);
+      result.contents.push_back(contents[j] * scale);
+      result.errors.push_back(errors[j] * scale);
+      j++;
+    } else {
+      result.indexes.push_back(indexes[j]);
+      result.contents.push_back(sum.contents[i] + contents[j] * scale);
+      result.errors.push_back(std::sqrt(sum.errors[i] * sum.errors[i] + errors[j] * errors[j] * scale * scale));
+      i++;
+      j++;
+    }
+  }
+  sum = std::move(result);
+}
+
+// equivalent of compareCells() for a sparse slice and a sparse normalized reference. Only the cells that are non-empty
+// in at least one of the two are visited, and the indexes of the bad cells are returned in increasing order.
+// The optional MADs are given as sparse cells (in the contents), the cells missing from them have a zero MAD.
+template <class T>
+inline size_t compareSparseCells(const CellWindow& window, const uint32_t* indexes, const T* contents, const T* errors,
+                                 size_t n, double norm, const SparseCells& reference,
+                                 double threshold, double nSigma, std::vector<uint32_t>& badCells,
+                                 const SparseCells* referenceMADs = nullptr, double madThreshold = 0)
+{
+  badCells.clear();
+  auto check = [&](uint32_t cell, double c1, double e1, double c2, double e2) {
+    if (!isInWindow(window, cell)) return;
+    if (referenceMADs) {
+      auto it = std::lower_bound(referenceMADs->indexes.begin(), referenceMADs->indexes.end(), cell);
+      double mad = (it != referenceMADs->indexes.end() && *it == cell) ? referenceMADs->contents[it - referenceMADs->indexes.begin()] : 0;
+      if (getMADDeviation(c1, e1, c2, e2, mad) > madThreshold) {
+        badCells.push_back(cell);
+      }
+      return;
+    }
+    double ratio = 0;
+    double error = 0;
+    if (c2 != 0) {
+      ratio = c1 / c2;
+      error = std::sqrt(e1 * e1 * c2 * c2 + e2 * e2 * c1 * c1) / (c2 * c2);
+    }
+    double deviation = (c1 == 0 && c2 == 0) ? 0 : std::fabs(ratio - 1.0);
+    if (deviation > threshold + error * nSigma) {
+      badCells.push_back(cell);
+    }
+  };
+
+  size_t i = 0;
+  size_t j = 0;
+  while (i < n || j < reference.size()) {
+    if (j >= reference.size() || (i < n && indexes[i] < reference.indexes[j])) {
+      check(indexes[i], contents[i] * norm, errors[i] * norm, 0, 0);
+      i++;
+    } else if (i >= n || reference.indexes[j] < indexes[i]) {
+      check(reference.indexes[j], 0, 0, reference.contents[j], reference.errors[j]);
+      j++;
+    } else {
+      check(indexes[i], contents[i] * norm, errors[i] * norm, reference.contents[j], reference.errors[j]);
+      i++;
+      j++;
+    }
+  }
+  return badCells.size();
+}
+
+// equivalent of findConnectedRegions() for a sorted list of bad cells, the neighbours are looked up by binary search
+inline std::vector<CellRegion> findConnectedRegions(const CellWindow& window, const std::vector<uint32_t>& badCells, size_t minSize)
+{
+  std::vector<CellRegion> regions;
+  std::vector<uint8_t> visited(badCells.size(), 0);
+  std::vector<size_t> stack;
+  int stride = window.stride();
+
+  for (size_t seed = 0; seed < badCells.size(); seed++) {
+    if (visited[seed]) continue;
+    int x = badCells[seed] % stride;
+    int y = badCells[seed] / stride;
+    CellRegion region{ 0, x, x, y, y };
+    visited[seed] = 1;
+    stack.push_back(seed);
+    while (!stack.empty()) {
+      size_t i = stack.back();
+      stack.pop_back();
+      int cx = badCells[i] % stride;
+      int cy = badCells[i] / stride;
+      region.size += 1;
+      region.xMin = std::min(region.xMin, cx);
+      region.xMax = std::max(region.xMax, cx);
+      region.yMin = std::min(region.yMin, cy);
+      region.yMax = std::max(region.yMax, cy);
+
+      const int dx[4] = { -1, 1, 0, 0 };
+      const int dy[4] = { 0, 0, -1, 1 };
+      for (int k = 0; k < 4; k++) {
+        int nx = cx + dx[k];
+        int ny = cy + dy[k];
+        if (nx < window.xFirst || nx > window.xLast || ny < window.yFirst || ny > window.yLast) continue;
+        uint32_t neighbour = ny * stride + nx;
+        auto it = std::lower_bound(badCells.begin(), badCells.end(), neighbour);
+        if (it == badCells.end() || *it != neighbour) continue;
+        size_t j = it - badCells.begin();
+        if (visited[j]) continue;
+        visited[j] = 1;
+        stack.push_back(j);
+      }
+    }
+    if (region.size >= minSize) {
+      regions.push_back(region);
+    }
+  }
+  return regions;
+}
+
+#endif // AQC_COMPARE2D_H_
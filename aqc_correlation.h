@@ -0,0 +1,255 @@
+#ifndef AQC_CORRELATION_H_
+#define AQC_CORRELATION_H_
+
+#include <algorithm>
+#include <map>
+#include <string>
+#include <vector>
+
+// Correlation of the check results of different plots of the same detector. A real detector problem usually makes
+// several related plots deviate at the same time, while isolated single-plot flags are often statistical noise.
+
+// check result of one time slice of one plot. The deviation score is the fraction of bad bins divided by the maximum
+// allowed one, such that slices with a score larger than one are bad
+struct ScoredSlice
+{
+  int run{ 0 };
+  long min{ 0 };
+  long max{ 0 };
+  double score{ 0 };
+  bool bad{ false };
+};
+
+// deviation scores of all the checked slices, for each group of plots (detector) and plot
+class DeviationScoreStore
+{
+ public:
+  void insert(const std::string& group, const std::string& plotName, const ScoredSlice& slice)
+  {
+    mScores[group][plotName].push_back(slice);
+  }
+
+  void clear() { mScores.clear(); }
+  bool empty() const { return mScores.empty(); }
+
+  const std::map<std::string, std::map<std::string, std::vector<ScoredSlice>>>& getGroups() const { return mScores; }
+
+ private:
+  std::map<std::string, std::map<std::string, std::vector<ScoredSlice>>> mScores;
+};
+
+// time range of a run in which at least the requested number of plots deviate together
+struct CorrelatedRange
+{
+  int run{ 0 };
+  long min{ 0 };
+  long max{ 0 };
+  std::vector<std::string> plots;
+  // largest number of plots deviating at the same time within the range
+  size_t nPlots{ 0 };
+  double meanScore{ 0 };
+  // probability that the coincidence is not due to independent random flags of the plots
+  double confidence{ 0 };
+};
+
+// Probability that at least k out of n independent plots are bad at the same time, given the probability of each plot
+// to be bad (Poisson binomial distribution, computed by recursion over the plots).
+inline double getCoincidenceProbability(const std::vector<double>& probabilities, size_t k)
+{
+  // p[j] = probability that exactly j of the plots considered so far are bad
+  std::vector<double> p(probabilities.size() + 1, 0);
+  p[0] = 1;
+  for (size_t i = 0; i < probabilities.size(); i++) {
+    for (size_t j = i + 1; j > 0; j--) {
+      p[j] = p[j] * (1 - probabilities[i]) + p[j - 1] * probabilities[i];
+    }
+    p[0] *= (1 - probabilities[i]);
+  }
+  double result = 0;
+  for (size_t j = k; j < p.size(); j++) {
+    result += p[j];
+  }
+  return std::min(result, 1.0);
+}
+
+// Slice x plot matrix of the deviation scores of one group of plots, and the derived co-occurrence statistics.
+// The slices of different plots do not necessarily have the same boundaries, therefore the time of each run is split
+// into elementary segments at the boundaries of all the slices, and each segment takes the score of the slice of each
+// plot that covers it. Segments not covered by a plot have a negative score.
+struct CorrelationMatrix
+{
+  std::vector<std::string> plots;
+  std::vector<int> segmentRuns;
+  std::vector<long> segmentMin;
+  std::vector<long> segmentMax;
+  // segments x plots, row-major
+  std::vector<double> scores;
+  std::vector<char> bad;
+  // duration in which each plot is checked, and in which it is bad
+  std::vector<double> checkedDurations;
+  std::vector<double> badDurations;
+  // plots x plots duration in which both plots are bad
+  std::vector<double> coDurations;
+
+  size_t size() const { return segmentRuns.size(); }
+  double score(size_t segment, size_t plot) const { return scores[segment * plots.size() + plot]; }
+  bool isBad(size_t segment, size_t plot) const { return bad[segment * plots.size() + plot]; }
+
+  // fraction of the checked time in which a plot is bad
+  double getBadProbability(size_t plot) const
+  {
+    return (checkedDurations[plot] > 0) ? badDurations[plot] / checkedDurations[plot] : 0;
+  }
+
+  // duration in which both plots are bad, divided by the duration in which at least one of them is bad (Jaccard index)
+  double getCoOccurrence(size_t plot1, size_t plot2) const
+  {
+    double both = coDurations[plot1 * plots.size() + plot2];
+    double either = badDurations[plot1] + badDurations[plot2] - both;
+    return (either > 0) ? both / either : 0;
+  }
+
+  void fill(const std::map<std::string, std::vector<ScoredSlice>>& plotSlices)
+  {
+    *this = CorrelationMatrix();
+    // slices of each run, for each plot
+    std::map<int, std::vector<std::vector<const ScoredSlice*>>> runSlices;
+    for (auto& [plotName, slices] : plotSlices) {
+      size_t plot = plots.size();
+      plots.push_back(plotName);
+      for (auto& slice : slices) {
+        auto& perPlot = runSlices[slice.run];
+        perPlot.resize(plotSlices.size());
+        perPlot[plot].push_back(&slice);
+      }
+    }
+    size_t nPlots = plots.size();
+
+    for (auto& [run, perPlot] : runSlices) {
+      std::vector<long> boundaries;
+      for (auto& slices : perPlot) {
+        for (auto* slice : slices) {
+          boundaries.push_back(slice->min);
+          boundaries.push_back(slice->max);
+        }
+      }
+      std::sort(boundaries.begin(), boundaries.end());
+      boundaries.erase(std::unique(boundaries.begin(), boundaries.end()), boundaries.end());
+      if (boundaries.size() < 2) continue;
+
+      size_t nSegments = boundaries.size() - 1;
+      std::vector<double> runScores(nSegments * nPlots, -1);
+      std::vector<char> runBad(nSegments * nPlots, 0);
+      for (size_t plot = 0; plot < nPlots; plot++) {
+        for (auto* slice : perPlot[plot]) {
+          size_t first = std::lower_bound(boundaries.begin(), boundaries.end(), slice->min) - boundaries.begin();
+          size_t last = std::lower_bound(boundaries.begin(), boundaries.end(), slice->max) - boundaries.begin();
+          // overlapping slices of the same plot are combined by keeping the worst result
+          for (size_t segment = first; segment < last; segment++) {
+            double& score = runScores[segment * nPlots + plot];
+            score = std::max(score, slice->score);
+            runBad[segment * nPlots + plot] |= slice->bad;
+          }
+        }
+      }
+
+      // only the segments covered by at least one plot are kept
+      for (size_t segment = 0; segment < nSegments; segment++) {
+        auto begin = runScores.begin() + segment * nPlots;
+        if (std::all_of(begin, begin + nPlots, [](double s) { return s < 0; })) continue;
+        segmentRuns.push_back(run);
+        segmentMin.push_back(boundaries[segment]);
+        segmentMax.push_back(boundaries[segment + 1]);
+        scores.insert(scores.end(), begin, begin + nPlots);
+        bad.insert(bad.end(), runBad.begin() + segment * nPlots, runBad.begin() + (segment + 1) * nPlots);
+      }
+    }
+
+    checkedDurations.assign(nPlots, 0);
+    badDurations.assign(nPlots, 0);
+    coDurations.assign(nPlots * nPlots, 0);
+    for (size_t segment = 0; segment < size(); segment++) {
+      double duration = segmentMax[segment] - segmentMin[segment];
+      for (size_t i = 0; i < nPlots; i++) {
+        if (score(segment, i) >= 0) checkedDurations[i] += duration;
+        if (!isBad(segment, i)) continue;
+        badDurations[i] += duration;
+        for (size_t j = 0; j < nPlots; j++) {
+          if (isBad(segment, j)) coDurations[i * nPlots + j] += duration;
+        }
+      }
+    }
+  }
+
+  // Time ranges where at least minPlots plots are bad at the same time. Consecutive segments fulfilling the condition
+  // are merged into one range. For each segment, the confidence is one minus the probability of observing at least
+  // as many bad plots by chance if the plots were flagged independently, with their average bad probabilities over
+  // the whole period; the confidence of a range is the largest one of its segments.
+  std::vector<CorrelatedRange> findCorrelatedRanges(size_t minPlots) const
+  {
+    std::vector<CorrelatedRange> ranges;
+    size_t nPlots = plots.size();
+    std::vector<double> badProbabilities(nPlots);
+    for (size_t plot = 0; plot < nPlots; plot++) {
+      badProbabilities[plot] = getBadProbability(plot);
+    }
+
+    bool open = false;
+    double sumScores = 0;
+    size_t nScores = 0;
+    std::vector<char> rangePlots(nPlots, 0);
+    auto closeRange = [&]() {
+      auto& range = ranges.back();
+      for (size_t plot = 0; plot < nPlots; plot++) {
+        if (rangePlots[plot]) range.plots.push_back(plots[plot]);
+      }
+      range.meanScore = (nScores > 0) ? sumScores / nScores : 0;
+      open = false;
+    };
+
+    std::vector<double> probabilities;
+    for (size_t segment = 0; segment < size(); segment++) {
+      size_t nBad = 0;
+      probabilities.clear();
+      for (size_t plot = 0; plot < nPlots; plot++) {
+        if (score(segment, plot) < 0) continue;
+        probabilities.push_back(badProbabilities[plot]);
+        nBad += isBad(segment, plot) ? 1 : 0;
+      }
+
+      bool contiguous = open && ranges.back().run == segmentRuns[segment] && ranges.back().max == segmentMin[segment];
+      if (open && (nBad < minPlots || !contiguous)) {
+        closeRange();
+      }
+      if (nBad < minPlots || nBad == 0) continue;
+
+      if (!open) {
+        CorrelatedRange range;
+        range.run = segmentRuns[segment];
+        range.min = segmentMin[segment];
+        range.max = segmentMax[segment];
+        ranges.push_back(range);
+        std::fill(rangePlots.begin(), rangePlots.end(), 0);
+        sumScores = 0;
+        nScores = 0;
+        open = true;
+      }
+      auto& range = ranges.back();
+      range.max = segmentMax[segment];
+      range.nPlots = std::max(range.nPlots, nBad);
+      range.confidence = std::max(range.confidence, 1 - getCoincidenceProbability(probabilities, nBad));
+      for (size_t plot = 0; plot < nPlots; plot++) {
+        if (!isBad(segment, plot)) continue;
+        rangePlots[plot] = 1;
+        sumScores += score(segment, plot);
+        nScores += 1;
+      }
+    }
+    if (open) {
+      closeRange();
+    }
+    return ranges;
+  }
+};
+
+#endif // AQC_CORRELATION_H_
@@ -0,0 +1,130 @@
+#ifndef AQC_INTERVALS_H_
+#define AQC_INTERVALS_H_
+
+#include <algorithm>
+#include <iterator>
+#include <map>
+#include <string>
+#include <vector>
+
+// overlap of two time intervals, relative to the longest of the two. Equal to one for identical intervals
+inline double getOverlapFraction(long min1, long max1, long min2, long max2)
+{
+  long overlap = std::min(max1, max2) - std::max(min1, min2);
+  long duration = std::max(max1 - min1, max2 - min2);
+  return (overlap > 0 && duration > 0) ? double(overlap) / duration : 0;
+}
+
+// Set of disjoint closed time intervals [min, max], ordered by their lower limit.
+// Intervals that overlap or touch the inserted one are merged with it, such that
+// insertion costs O(log n) plus the number of merged intervals.
+class IntervalSet
+{
+ public:
+  void insert(long min, long max)
+  {
+    // first interval that starts after the end of the new one, all the overlapping ones are before it
+    auto it = mIntervals.upper_bound(max);
+    while (it != mIntervals.begin()) {
+      auto prev = std::prev(it);
+      if (prev->second < min) {
+        break;
+      }
+      min = std::min(min, prev->first);
+      max = std::max(max, prev->second);
+      it = mIntervals.erase(prev);
+    }
+    mIntervals.emplace(min, max);
+  }
+
+  bool overlaps(long min, long max) const
+  {
+    auto it = mIntervals.upper_bound(max);
+    if (it == mIntervals.begin()) {
+      return false;
+    }
+    return std::prev(it)->second >= min;
+  }
+
+  long getTotalDuration() const
+  {
+    long result = 0;
+    for (auto& [min, max] : mIntervals) {
+      result += max - min;
+    }
+    return result;
+  }
+
+  bool empty() const { return mIntervals.empty(); }
+  size_t size() const { return mIntervals.size(); }
+  const std::map<long, long>& getIntervals() const { return mIntervals; }
+
+ private:
+  // lower limit -> upper limit
+  std::map<long, long> mIntervals;
+};
+
+// Bad time intervals of each run, stored separately for each plot and aggregated over all plots
+class BadIntervalStore
+{
+ public:
+  void insert(int run, const std::string& plotName, long min, long max)
+  {
+    auto& runIntervals = mRuns[run];
+    runIntervals.plots[plotName].insert(min, max);
+    runIntervals.all.insert(min, max);
+  }
+
+  void clear() { mRuns.clear(); }
+  bool empty() const { return mRuns.empty(); }
+
+  std::vector<int> getRuns() const
+  {
+    std::vector<int> result;
+    for (auto& [run, runIntervals] : mRuns) {
+      result.push_back(run);
+    }
+    return result;
+  }
+
+  // bad intervals for each plot of a given run
+  const std::map<std::string, IntervalSet>& getPlotIntervals(int run) const
+  {
+    static const std::map<std::string, IntervalSet> empty;
+    auto it = mRuns.find(run);
+    return (it == mRuns.end()) ? empty : it->second.plots;
+  }
+
+  // union of the bad intervals of all the plots of a given run
+  const IntervalSet& getRunIntervals(int run) const
+  {
+    static const IntervalSet empty;
+    auto it = mRuns.find(run);
+    return (it == mRuns.end()) ? empty : it->second.all;
+  }
+
+  // names of the plots that flag at least part of the [min, max] time range of a given run
+  std::vector<std::string> getPlotsInRange(int run, long min, long max) const
+  {
+    std::vector<std::string> result;
+    for (auto& [plotName, intervals] : getPlotIntervals(run)) {
+      if (intervals.overlaps(min, max)) {
+        result.push_back(plotName);
+      }
+    }
+    return result;
+  }
+
+  // total duration of the bad intervals of a given run, without double-counting the plots
+  long getBadDuration(int run) const { return getRunIntervals(run).getTotalDuration(); }
+
+ private:
+  struct RunIntervals
+  {
+    std::map<std::string, IntervalSet> plots;
+    IntervalSet all;
+  };
+  std::map<int, RunIntervals> mRuns;
+};
+
+#endif // AQC_INTERVALS_H_
@@ -0,0 +1,303 @@
+#ifndef AQC_LOG_H_
+#define AQC_LOG_H_
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <format>
+#include <iostream>
+#include <mutex>
+#include <streambuf>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Asynchronous logger with levels and per-subsystem filtering.
+// The messages are formatted directly into the slots of a fixed-size lock-free ring buffer, and written to the standard
+// output by a background thread, such that the processing threads never wait for the terminal or the log file. The
+// disabled messages are discarded before any formatting.
+// While the writer thread runs, a stream that waits for it is tied to std::cout, such that the messages submitted
+// before a std::cout output are always written before it, in the same order as in the code.
+
+enum class LogLevel : int {
+  Debug = 0,
+  Info,
+  Warning,
+  Error
+};
+
+enum class LogSubsystem : int {
+  // configuration and reading of the input files or of the QCDB
+  Input = 0,
+  // interaction rates from the CTP scalers
+  Rate,
+  // reference runs and reference plots
+  Reference,
+  // comparisons with the reference plots
+  Check,
+  // trend analysis
+  Trend,
+  // incremental state and binary cache
+  State,
+  NSubsystems
+};
+
+inline const char* getLogSubsystemName(LogSubsystem subsystem)
+{
+  static const char* names[] = { "input", "rate", "reference", "check", "trend", "state" };
+  return names[static_cast<int>(subsystem)];
+}
+
+inline bool parseLogLevel(const std::string& name, LogLevel& level)
+{
+  static const std::array<std::pair<const char*, LogLevel>, 4> levels{ { { "debug", LogLevel::Debug },
+                                                                          { "info", LogLevel::Info },
+                                                                          { "warning", LogLevel::Warning },
+                                                                          { "error", LogLevel::Error } } };
+  for (auto& [levelName, value] : levels) {
+    if (name == levelName) {
+      level = value;
+      return true;
+    }
+  }
+  return false;
+}
+
+inline bool parseLogSubsystem(const std::string& name, LogSubsystem& subsystem)
+{
+  for (int i = 0; i < static_cast<int>(LogSubsystem::NSubsystems); i++) {
+    if (name == getLogSubsystemName(static_cast<LogSubsystem>(i))) {
+      subsystem = static_cast<LogSubsystem>(i);
+      return true;
+    }
+  }
+  return false;
+}
+
+class AsyncLogger
+{
+ public:
+  // maximum length of one message, longer messages are truncated
+  static constexpr size_t kMessageSize = 500;
+  // number of slots of the ring buffer, must be a power of two
+  static constexpr size_t kNSlots = 4096;
+
+  AsyncLogger() : mSlots(kNSlots)
+  {
+    for (size_t i = 0; i < kNSlots; i++) {
+      mSlots[i].sequence.store(i, std::memory_order_relaxed);
+    }
+    mLevels.fill(LogLevel::Warning);
+  }
+
+  ~AsyncLogger() { stop(); }
+
+  AsyncLogger(const AsyncLogger&) = delete;
+  AsyncLogger& operator=(const AsyncLogger&) = delete;
+
+  void setLevel(LogLevel level) { mLevels.fill(level); }
+  void setLevel(LogSubsystem subsystem, LogLevel level) { mLevels[static_cast<int>(subsystem)] = level; }
+
+  bool isEnabled(LogLevel level, LogSubsystem subsystem) const
+  {
+    return level >= mLevels[static_cast<int>(subsystem)];
+  }
+
+  template <class... Args>
+  void log(LogLevel level, LogSubsystem subsystem, std::format_string<Args...> fmt, Args&&... args)
+  {
+    if (!isEnabled(level, subsystem)) {
+      return;
+    }
+    start();
+
+    size_t position = reserveSlot();
+    Slot& slot = mSlots[position & (kNSlots - 1)];
+    auto result = std::format_to_n(slot.text, kMessageSize - 1, fmt, std::forward<Args>(args)...);
+    slot.size = std::min<size_t>(result.size, kMessageSize - 1);
+    slot.text[slot.size] = '\n';
+    slot.size += 1;
+    slot.sequence.store(position + 1, std::memory_order_release);
+  }
+
+  // wait until all the messages submitted so far are passed to the standard output
+  void wait()
+  {
+    size_t target = mEnqueuePosition.load(std::memory_order_acquire);
+    while (mRunning.load(std::memory_order_acquire) && mDequeuePosition.load(std::memory_order_acquire) < target) {
+      std::this_thread::sleep_for(std::chrono::microseconds(100));
+    }
+  }
+
+  // wait until all the messages submitted so far are written, for example before forking
+  void flush()
+  {
+    wait();
+    std::fflush(stdout);
+  }
+
+  // drain the buffer and stop the writer thread, which is started again at the next message. It must be called
+  // before forking, since the child process would not inherit the writer thread
+  void stop()
+  {
+    std::lock_guard<std::mutex> lock(mStartMutex);
+    if (!mRunning.load(std::memory_order_acquire)) {
+      return;
+    }
+    flush();
+    mStopRequested.store(true, std::memory_order_release);
+    mWriterThread.join();
+    if (std::cout.tie() == &mCoutSync) {
+      std::cout.tie(nullptr);
+    }
+    mRunning.store(false, std::memory_order_release);
+  }
+
+ private:
+  struct Slot
+  {
+    std::atomic<size_t> sequence{ 0 };
+    size_t size{ 0 };
+    char text[kMessageSize];
+  };
+
+  // the state only changes under the lock, as in stop(). The running flag is set before the writer thread is created,
+  // such that the thread and the flushes always see the state of the current start
+  void start()
+  {
+    if (mRunning.load(std::memory_order_acquire)) {
+      return;
+    }
+    std::lock_guard<std::mutex> lock(mStartMutex);
+    if (mRunning.load(std::memory_order_acquire)) {
+      return;
+    }
+    mStopRequested.store(false, std::memory_order_release);
+    mRunning.store(true, std::memory_order_release);
+    try {
+      mWriterThread = std::thread([this]() { drain(); });
+    } catch (...) {
+      mRunning.store(false, std::memory_order_release);
+      throw;
+    }
+    if (!std::cout.tie()) {
+      std::cout.tie(&mCoutSync);
+    }
+  }
+
+  // stream tied to std::cout: before each output operation on std::cout, its flush waits for the writer thread
+  class SyncBuffer : public std::streambuf
+  {
+   public:
+    explicit SyncBuffer(AsyncLogger& logger) : mLogger(logger) {}
+
+   protected:
+    int sync() override
+    {
+      mLogger.wait();
+      return 0;
+    }
+
+   private:
+    AsyncLogger& mLogger;
+  };
+
+  // bounded multi-producer queue: each producer reserves a position with a compare-and-swap, and the slot becomes
+  // readable by the writer thread when its sequence number is advanced. When the buffer is full the producers wait
+  // for the writer thread, such that no message is lost
+  size_t reserveSlot()
+  {
+    size_t position = mEnqueuePosition.load(std::memory_order_relaxed);
+    while (true) {
+      Slot& slot = mSlots[position & (kNSlots - 1)];
+      size_t sequence = slot.sequence.load(std::memory_order_acquire);
+      if (sequence == position) {
+        if (mEnqueuePosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+          return position;
+        }
+      } else if (sequence < position) {
+        // buffer full
+        std::this_thread::yield();
+        position = mEnqueuePosition.load(std::memory_order_relaxed);
+      } else {
+        position = mEnqueuePosition.load(std::memory_order_relaxed);
+      }
+    }
+  }
+
+  void drain()
+  {
+    while (true) {
+      size_t position = mDequeuePosition.load(std::memory_order_relaxed);
+      size_t nWritten = 0;
+      while (true) {
+        Slot& slot = mSlots[position & (kNSlots - 1)];
+        if (slot.sequence.load(std::memory_order_acquire) != position + 1) {
+          break;
+        }
+        std::fwrite(slot.text, 1, slot.size, stdout);
+        slot.sequence.store(position + kNSlots, std::memory_order_release);
+        position += 1;
+        nWritten += 1;
+        mDequeuePosition.store(position, std::memory_order_release);
+      }
+      if (nWritten > 0) {
+        // one flush for each batch of messages instead of one for each line
+        std::fflush(stdout);
+        continue;
+      }
+      if (mStopRequested.load(std::memory_order_acquire)) {
+        break;
+      }
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+  }
+
+  std::vector<Slot> mSlots;
+  std::atomic<size_t> mEnqueuePosition{ 0 };
+  std::atomic<size_t> mDequeuePosition{ 0 };
+  std::array<LogLevel, static_cast<int>(LogSubsystem::NSubsystems)> mLevels;
+
+  SyncBuffer mCoutSyncBuffer{ *this };
+  std::ostream mCoutSync{ &mCoutSyncBuffer };
+
+  std::thread mWriterThread;
+  std::mutex mStartMutex;
+  std::atomic<bool> mRunning{ false };
+  std::atomic<bool> mStopRequested{ false };
+};
+
+inline AsyncLogger& getLogger()
+{
+  static AsyncLogger logger;
+  return logger;
+}
+
+template <class... Args>
+void logDebug(LogSubsystem subsystem, std::format_string<Args...> fmt, Args&&... args)
+{
+  getLogger().log(LogLevel::Debug, subsystem, fmt, std::forward<Args>(args)...);
+}
+
+template <class... Args>
+void logInfo(LogSubsystem subsystem, std::format_string<Args...> fmt, Args&&... args)
+{
+  getLogger().log(LogLevel::Info, subsystem, fmt, std::forward<Args>(args)...);
+}
+
+template <class... Args>
+void logWarning(LogSubsystem subsystem, std::format_string<Args...> fmt, Args&&... args)
+{
+  getLogger().log(LogLevel::Warning, subsystem, fmt, std::forward<Args>(args)...);
+}
+
+template <class... Args>
+void logError(LogSubsystem subsystem, std::format_string<Args...> fmt, Args&&... args)
+{
+  getLogger().log(LogLevel::Error, subsystem, fmt, std::forward<Args>(args)...);
+}
+
+#endif // AQC_LOG_H_
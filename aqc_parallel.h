@@ -0,0 +1,47 @@
+#ifndef AQC_PARALLEL_H_
+#define AQC_PARALLEL_H_
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <thread>
+#include <vector>
+
+// Run "task(item, worker)" for all items in [0, nItems) using up to nWorkers threads.
+// Items are handed out dynamically, so that slow items do not stall the other workers.
+// The worker index is in [0, nWorkers) and can be used to access per-thread resources,
+// like database connections, without locking.
+inline void runInParallel(size_t nItems, size_t nWorkers, const std::function<void(size_t, size_t)>& task)
+{
+  if (nItems == 0) {
+    return;
+  }
+  nWorkers = std::max<size_t>(1, std::min(nWorkers, nItems));
+
+  if (nWorkers == 1) {
+    for (size_t item = 0; item < nItems; item++) {
+      task(item, 0);
+    }
+    return;
+  }
+
+  std::atomic<size_t> nextItem{ 0 };
+  std::vector<std::thread> workers;
+  for (size_t worker = 0; worker < nWorkers; worker++) {
+    workers.emplace_back([&, worker]() {
+      while (true) {
+        size_t item = nextItem.fetch_add(1);
+        if (item >= nItems) {
+          break;
+        }
+        task(item, worker);
+      }
+    });
+  }
+  for (auto& t : workers) {
+    t.join();
+  }
+}
+
+#endif // AQC_PARALLEL_H_
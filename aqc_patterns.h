@@ -0,0 +1,49 @@
+#ifndef AQC_PATTERNS_H_
+#define AQC_PATTERNS_H_
+
+#include <iostream>
+#include <regex>
+#include <string>
+
+// The "name" of a plot can be a glob pattern (containing "*" or "?"), or a regular expression if "regex" is true.
+// The patterns are expanded into the names of the matching MOs, taken from the input files or from the QCDB listing.
+
+// regular expression equivalent to a glob pattern, where "*" matches any sequence of characters (including "/")
+// and "?" matches any single character
+inline std::string getRegexFromGlob(const std::string& glob)
+{
+  std::string result;
+  for (char c : glob) {
+    if (c == '*') result += ".*";
+    else if (c == '?') result += ".";
+    else if (std::string("\\^$.|+()[]{}").find(c) != std::string::npos) result += std::string("\\") + c;
+    else result += c;
+  }
+  return result;
+}
+
+// regular expression corresponding to a plot name, empty if the name is a plain MO name
+inline std::string getPlotNameRegex(const std::string& name, bool isRegex)
+{
+  if (isRegex) {
+    return name;
+  }
+  if (name.find_first_of("*?") != std::string::npos) {
+    return getRegexFromGlob(name);
+  }
+  return std::string();
+}
+
+// compile the regular expression of a name pattern. Invalid user expressions are reported instead of throwing
+inline bool compilePlotNameRegex(const std::string& pattern, const std::string& regex, std::regex& result)
+{
+  try {
+    result = std::regex(regex);
+  } catch (const std::regex_error& e) {
+    std::cout << "Invalid name pattern \"" << pattern << "\": " << e.what() << std::endl;
+    return false;
+  }
+  return true;
+}
+
+#endif // AQC_PATTERNS_H_
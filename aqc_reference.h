@@ -0,0 +1,256 @@
+#ifndef AQC_REFERENCE_H_
+#define AQC_REFERENCE_H_
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <limits>
+#include <vector>
+
+#include "./aqc_parallel.h"
+
+// Euclidean distance between two vectors of n values.
+// The sum is split over four independent accumulators, such that the loop can be vectorized
+// without relaxing the floating point semantics.
+inline double getEuclideanDistance(const double* a, const double* b, size_t n)
+{
+  double sum[4] = { 0, 0, 0, 0 };
+  size_t k = 0;
+  for (; k + 4 <= n; k += 4) {
+    for (size_t l = 0; l < 4; l++) {
+      double d = a[k + l] - b[k + l];
+      sum[l] += d * d;
+    }
+  }
+  for (; k < n; k++) {
+    double d = a[k] - b[k];
+    sum[0] += d * d;
+  }
+  return std::sqrt((sum[0] + sum[1]) + (sum[2] + sum[3]));
+}
+
+// Index of the medoid of the rows of a row-major nRows x nCols matrix, i.e. the row with the smallest sum of
+// distances to all the other rows. The pairwise distances are computed in parallel, one row per work item.
+// If distanceSums is given, it is filled with the sum of the distances of each row to all the others.
+inline size_t findMedoid(const std::vector<double>& rows, size_t nRows, size_t nCols, size_t nWorkers,
+                         std::vector<double>* distanceSums = nullptr)
+{
+  std::vector<double> distances(nRows * nRows, 0);
+  runInParallel(nRows, nWorkers, [&](size_t i, size_t) {
+    for (size_t j = i + 1; j < nRows; j++) {
+      distances[i * nRows + j] = getEuclideanDistance(rows.data() + i * nCols, rows.data() + j * nCols, nCols);
+    }
+  });
+
+  std::vector<double> sums(nRows, 0);
+  for (size_t i = 0; i < nRows; i++) {
+    for (size_t j = i + 1; j < nRows; j++) {
+      sums[i] += distances[i * nRows + j];
+      sums[j] += distances[i * nRows + j];
+    }
+  }
+
+  size_t medoid = 0;
+  double minSum = std::numeric_limits<double>::max();
+  for (size_t i = 0; i < nRows; i++) {
+    if (sums[i] < minSum) {
+      minSum = sums[i];
+      medoid = i;
+    }
+  }
+
+  if (distanceSums) {
+    *distanceSums = sums;
+  }
+  return medoid;
+}
+
+// Median of n values, partially reordering them with a selection algorithm instead of a full sort
+inline double getMedianInPlace(double* values, size_t n)
+{
+  if (n == 0) {
+    return 0;
+  }
+  double* middle = values + n / 2;
+  std::nth_element(values, middle, values + n);
+  if (n % 2 == 1) {
+    return *middle;
+  }
+  // for an even number of values, the lower middle one is the largest of the first half
+  return (*middle + *std::max_element(values, middle)) / 2;
+}
+
+// Median and median absolute deviation (MAD) of each row of a bins-major nBins x nSlices matrix.
+// Each row is copied into a scratch buffer, such that the input is left untouched.
+inline void computeMedianAndMAD(const std::vector<double>& values, size_t nBins, size_t nSlices,
+                                std::vector<double>& medians, std::vector<double>& mads)
+{
+  medians.assign(nBins, 0);
+  mads.assign(nBins, 0);
+  std::vector<double> scratch(nSlices);
+  for (size_t bin = 0; bin < nBins; bin++) {
+    const double* row = values.data() + bin * nSlices;
+    std::copy(row, row + nSlices, scratch.begin());
+    double median = getMedianInPlace(scratch.data(), nSlices);
+    for (size_t slice = 0; slice < nSlices; slice++) {
+      scratch[slice] = std::fabs(row[slice] - median);
+    }
+    medians[bin] = median;
+    mads[bin] = getMedianInPlace(scratch.data(), nSlices);
+  }
+}
+
+// Deviation of a normalized value from the reference, in units of the MAD of the rate interval scaled to the standard
+// deviation of a normal distribution. The scaled MAD is floored at the statistical uncertainty of the difference, such
+// that the bins with identical values in most slices (MAD = 0) are still checked against their fluctuations instead of
+// being silently skipped. Without any spread nor uncertainty, any difference is an infinite deviation
+inline double getMADDeviation(double value, double error, double reference, double referenceError, double mad)
+{
+  double sigma = std::max(1.4826 * mad, std::sqrt(error * error + referenceError * referenceError));
+  if (sigma <= 0) {
+    return (value == reference) ? 0 : std::numeric_limits<double>::infinity();
+  }
+  return std::fabs(value - reference) / sigma;
+}
+
+// Polynomial model of the dependence of each bin on a variable x (for example the interaction rate), obtained from a
+// weighted least-squares fit of the values of all the slices at once.
+// The values and errors are stored bins-major, i.e. the nSlices values of a given bin are contiguous, such that the
+// sums over the slices are vectorizable. Slices with zero error have zero weight in the fit of the corresponding bin.
+struct BinPolynomialModel
+{
+  int degree{ -1 };
+  size_t nBins{ 0 };
+  // (degree + 1) coefficients for each bin, in increasing order of power
+  std::vector<double> coefficients;
+  // (degree + 1) x (degree + 1) covariance matrix of the coefficients of each bin
+  std::vector<double> covariances;
+
+  bool empty() const { return degree < 0; }
+
+  void fit(const std::vector<double>& values, const std::vector<double>& errors, const std::vector<double>& x,
+           size_t nBinsIn, int degreeIn)
+  {
+    degree = degreeIn;
+    nBins = nBinsIn;
+    size_t nSlices = x.size();
+    size_t nPars = degree + 1;
+    coefficients.assign(nBins * nPars, 0);
+    covariances.assign(nBins * nPars * nPars, 0);
+
+    // powers of x up to 2 * degree, for the normal equations
+    std::vector<std::vector<double>> powers(2 * degree + 1, std::vector<double>(nSlices, 1));
+    for (size_t k = 1; k < powers.size(); k++) {
+      for (size_t slice = 0; slice < nSlices; slice++) {
+        powers[k][slice] = powers[k - 1][slice] * x[slice];
+      }
+    }
+
+    std::vector<double> weights(nSlices);
+    std::vector<double> sumsW(2 * degree + 1);
+    std::vector<double> sumsWY(nPars);
+    for (size_t bin = 0; bin < nBins; bin++) {
+      const double* y = values.data() + bin * nSlices;
+      const double* e = errors.data() + bin * nSlices;
+      for (size_t slice = 0; slice < nSlices; slice++) {
+        weights[slice] = (e[slice] > 0) ? 1.0 / (e[slice] * e[slice]) : 0;
+      }
+      for (size_t k = 0; k < sumsW.size(); k++) {
+        double sum = 0;
+        for (size_t slice = 0; slice < nSlices; slice++) {
+          sum += weights[slice] * powers[k][slice];
+        }
+        sumsW[k] = sum;
+      }
+      for (size_t k = 0; k < nPars; k++) {
+        double sum = 0;
+        for (size_t slice = 0; slice < nSlices; slice++) {
+          sum += weights[slice] * y[slice] * powers[k][slice];
+        }
+        sumsWY[k] = sum;
+      }
+
+      // if there are not enough points to constrain the full polynomial, the degree is reduced for this bin
+      for (int binDegree = degree; binDegree >= 0; binDegree--) {
+        if (solve(sumsW, sumsWY, binDegree, coefficients.data() + bin * nPars, covariances.data() + bin * nPars * nPars)) {
+          break;
+        }
+      }
+    }
+  }
+
+  // expected value and its uncertainty for each bin at the given x
+  void predict(double xValue, double* values, double* errors) const
+  {
+    size_t nPars = degree + 1;
+    std::vector<double> powers(nPars, 1);
+    for (size_t k = 1; k < nPars; k++) {
+      powers[k] = powers[k - 1] * xValue;
+    }
+    for (size_t bin = 0; bin < nBins; bin++) {
+      const double* c = coefficients.data() + bin * nPars;
+      const double* cov = covariances.data() + bin * nPars * nPars;
+      double value = 0;
+      double variance = 0;
+      for (size_t i = 0; i < nPars; i++) {
+        value += c[i] * powers[i];
+        for (size_t j = 0; j < nPars; j++) {
+          variance += powers[i] * cov[i * nPars + j] * powers[j];
+        }
+      }
+      values[bin] = value;
+      errors[bin] = std::sqrt(std::max(variance, 0.0));
+    }
+  }
+
+ private:
+  // solve the normal equations of a polynomial of degree n by Gauss-Jordan elimination, the inverse of the
+  // normal matrix is the covariance matrix of the coefficients. Returns false if the matrix is singular.
+  bool solve(const std::vector<double>& sumsW, const std::vector<double>& sumsWY, int n, double* c, double* cov) const
+  {
+    size_t nPars = degree + 1;
+    size_t m = n + 1;
+    // augmented matrix [M | I | b]
+    std::vector<double> a(m * (2 * m + 1), 0);
+    auto at = [&](size_t i, size_t j) -> double& { return a[i * (2 * m + 1) + j]; };
+    for (size_t i = 0; i < m; i++) {
+      for (size_t j = 0; j < m; j++) {
+        at(i, j) = sumsW[i + j];
+      }
+      at(i, m + i) = 1;
+      at(i, 2 * m) = sumsWY[i];
+    }
+    for (size_t col = 0; col < m; col++) {
+      size_t pivot = col;
+      for (size_t row = col + 1; row < m; row++) {
+        if (std::fabs(at(row, col)) > std::fabs(at(pivot, col))) pivot = row;
+      }
+      if (std::fabs(at(pivot, col)) < 1.0e-12 * std::fabs(sumsW[0]) || at(pivot, col) == 0) {
+        return false;
+      }
+      for (size_t j = 0; j <= 2 * m; j++) {
+        std::swap(at(col, j), at(pivot, j));
+      }
+      double norm = at(col, col);
+      for (size_t j = 0; j <= 2 * m; j++) {
+        at(col, j) /= norm;
+      }
+      for (size_t row = 0; row < m; row++) {
+        if (row == col) continue;
+        double factor = at(row, col);
+        for (size_t j = 0; j <= 2 * m; j++) {
+          at(row, j) -= factor * at(col, j);
+        }
+      }
+    }
+    for (size_t i = 0; i < nPars; i++) {
+      c[i] = (i < m) ? at(i, 2 * m) : 0;
+      for (size_t j = 0; j < nPars; j++) {
+        cov[i * nPars + j] = (i < m && j < m) ? at(i, m + j) : 0;
+      }
+    }
+    return true;
+  }
+};
+
+#endif // AQC_REFERENCE_H_
@@ -0,0 +1,152 @@
+#ifndef AQC_TRENDS_H_
+#define AQC_TRENDS_H_
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+// Statistics that can be extracted from the bin contents of a histogram for the trends:
+// - "mean": mean of the histogram, as reported by ROOT
+// - "rms": standard deviation computed from the bin contents
+// - "integral": sum of the bin contents, excluding underflow and overflow
+// - "entries": number of entries of the histogram
+// - "fracInRange": fraction of the integral inside the check range
+// - "qNN": NN-th percentile, for example "q50" for the median
+struct TrendStatistic
+{
+  std::string name;
+  // quantile probability, only for the "qNN" statistics
+  double probability{ 0 };
+};
+
+inline bool parseTrendStatistic(const std::string& name, TrendStatistic& statistic)
+{
+  statistic = TrendStatistic{ name, 0 };
+  if (name == "mean" || name == "rms" || name == "integral" || name == "entries" || name == "fracInRange") {
+    return true;
+  }
+  if (name.size() > 1 && name[0] == 'q') {
+    char* end = nullptr;
+    double percent = std::strtod(name.c_str() + 1, &end);
+    if (*end == '\0' && percent >= 0 && percent <= 100) {
+      statistic.probability = percent / 100;
+      return true;
+    }
+  }
+  return false;
+}
+
+// Computes all the requested statistics of one histogram with a single pass over its nBins + 2 bin contents
+// (including underflow and overflow). The edges are the nBins + 1 bin limits, the results are written in the
+// order of the statistics. The cumulative sums needed for the quantiles are accumulated in the scratch buffer.
+// The contents are read in the precision of the store, the sums are done in double precision.
+template <class T>
+inline void computeTrendStatistics(const std::vector<TrendStatistic>& statistics, const T* contents,
+                                   const double* edges, int nBins, double mean, double entries,
+                                   double rangeMin, double rangeMax, std::vector<double>& scratch, double* results)
+{
+  scratch.resize(nBins + 1);
+  scratch[0] = 0;
+  double sumW = 0;
+  double sumWX = 0;
+  double sumWX2 = 0;
+  double sumInRange = 0;
+  bool hasRange = (rangeMin != rangeMax);
+  for (int bin = 1; bin <= nBins; bin++) {
+    double w = contents[bin];
+    double x = (edges[bin - 1] + edges[bin]) / 2;
+    sumW += w;
+    sumWX += w * x;
+    sumWX2 += w * x * x;
+    if (!hasRange || (x >= rangeMin && x <= rangeMax)) {
+      sumInRange += w;
+    }
+    scratch[bin] = sumW;
+  }
+
+  for (size_t i = 0; i < statistics.size(); i++) {
+    const auto& name = statistics[i].name;
+    double result = 0;
+    if (name == "mean") {
+      result = mean;
+    } else if (name == "rms") {
+      if (sumW > 0) {
+        double binMean = sumWX / sumW;
+        result = std::sqrt(std::max(sumWX2 / sumW - binMean * binMean, 0.0));
+      }
+    } else if (name == "integral") {
+      result = sumW;
+    } else if (name == "entries") {
+      result = entries;
+    } else if (name == "fracInRange") {
+      result = (sumW > 0) ? sumInRange / sumW : 0;
+    } else if (sumW > 0) {
+      // quantile, linearly interpolated inside the bin where the cumulative sum crosses the requested fraction
+      double target = statistics[i].probability * sumW;
+      auto it = std::lower_bound(scratch.begin() + 1, scratch.end(), target);
+      int bin = std::min<int>(it - scratch.begin(), nBins);
+      double binContent = scratch[bin] - scratch[bin - 1];
+      double fraction = (binContent > 0) ? (target - scratch[bin - 1]) / binContent : 0;
+      result = edges[bin - 1] + fraction * (edges[bin] - edges[bin - 1]);
+    }
+    results[i] = result;
+  }
+}
+
+// Compact table of the trend statistics of one plot, with one row per time slice.
+// The values are stored row-major, with one column per statistic.
+struct TrendTable
+{
+  std::vector<TrendStatistic> statistics;
+  std::vector<int> runNumbers;
+  std::vector<uint64_t> validityMin;
+  std::vector<uint64_t> validityMax;
+  std::vector<double> rates;
+  std::vector<double> values;
+
+  size_t size() const { return runNumbers.size(); }
+  double value(size_t row, size_t column) const { return values[row * statistics.size() + column]; }
+};
+
+// Two-sided CUSUM change-point detector, fed one standardized residual at a time.
+// The upward and downward cumulative sums are increased by the residuals exceeding the slack, and an alarm is raised
+// when one of them crosses the threshold. The change is estimated to start at the point where the corresponding sum
+// last left zero, and the detector is reset after each alarm such that a persisting shift raises new alarms.
+class CusumDetector
+{
+ public:
+  CusumDetector(double slack, double threshold) : mSlack(slack), mThreshold(threshold) {}
+
+  bool update(double residual, size_t index, size_t& changeStart)
+  {
+    if (mHigh == 0) mHighStart = index;
+    if (mLow == 0) mLowStart = index;
+    mHigh = std::max(0.0, mHigh + residual - mSlack);
+    mLow = std::max(0.0, mLow - residual - mSlack);
+    if (mHigh > mThreshold || mLow > mThreshold) {
+      changeStart = (mHigh > mThreshold) ? mHighStart : mLowStart;
+      reset();
+      return true;
+    }
+    return false;
+  }
+
+  void reset()
+  {
+    mHigh = 0;
+    mLow = 0;
+  }
+
+ private:
+  double mSlack;
+  double mThreshold;
+  double mHigh{ 0 };
+  double mLow{ 0 };
+  size_t mHighStart{ 0 };
+  size_t mLowStart{ 0 };
+};
+
+#endif // AQC_TRENDS_H_